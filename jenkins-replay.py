@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+
+"""Play back a frame trace recorded by jenkins-tree.py, to benchmark the
+serial/radio pipeline.
+
+When built with replay.conf, the transmitter answers every frame with a STAT
+line on the same UART, which gives the losses at the UART parser and at the
+advertising (or stream) update.
+If the receiver log is available (e.g. RTT piped to a file or a pty, or the
+receiver console in simulation), the frames it rendered are matched with the
+ones that were sent, which gives the losses at the scan stage and the pixel
+latency as seen by the host.
+
+Examples:
+    jenkins-replay.py trace.txt --port /dev/ttyACM0              # original speed
+    jenkins-replay.py trace.txt --port /dev/pts/3 --speed 10     # 10x speed
+    jenkins-replay.py trace.txt --port /dev/ttyACM0 --rx-log rx.log --ramp 5,5,10
+"""
+
+import argparse
+import binascii
+import itertools
+import re
+import statistics
+import threading
+import time
+
+import serial
+
+from juletre_trace import make_packet, read_trace
+
+# Must match the transmitter, which pads every frame to this size
+NUM_LEDS = 68
+DATA_LEN = NUM_LEDS * 4
+
+STAT_RE = re.compile(rb'STAT frames=(\d+) overflow=(\d+) adv=(\d+) stream=(\d+) congested=(\d+)')
+FRAME_RE = re.compile(rb'frame ([0-9a-f]{4}) ([0-9a-f]{4})')
+
+def frame_key(data):
+    """What the receiver logs for this frame: the CRC of the whole frame and
+    the sequence number from mark(). The CRC alone collides too often.
+    """
+    padded = data.ljust(DATA_LEN, b'\0')[:DATA_LEN]
+    return binascii.crc_hqx(padded, 0xffff), data[3] | (data[7] << 8)
+
+def mark(data, seq):
+    """Make every frame unique, so the receiver log can be matched to what was
+    sent. The sequence number goes in the effect bytes of the first two LEDs.
+    """
+    data = bytearray(data.ljust(8, b'\0'))
+    data[3] = seq & 0xff
+    data[7] = (seq >> 8) & 0xff
+    return bytes(data)
+
+class StatReader(threading.Thread):
+    """Parse the STAT lines sent back by the transmitter."""
+    def __init__(self, port):
+        super().__init__(daemon=True)
+        self.port = port
+        self.stat = None
+        self.updated = threading.Event()
+
+    def run(self):
+        while True:
+            line = self.port.readline()
+            m = STAT_RE.search(line)
+            if m:
+                frames, overflow, adv, stream, congested = map(int, m.groups())
+                self.stat = {'frames': frames, 'overflow': overflow, 'adv': adv,
+                             'stream': stream, 'congested': congested}
+                self.updated.set()
+
+class RxLogReader(threading.Thread):
+    """Follow the receiver log, and note when each frame shows up."""
+    def __init__(self, path):
+        super().__init__(daemon=True)
+        self.path = path
+        self.seen = {}
+
+    def run(self):
+        with open(self.path, 'rb') as f:
+            # Skip what was logged before we started, if it's a file
+            if f.seekable():
+                f.seek(0, 2)
+            partial = b''
+            while True:
+                line = partial + f.readline()
+                if not line.endswith(b'\n'):
+                    # Caught the writer mid-line, wait for the rest
+                    partial = line
+                    time.sleep(0.01)
+                    continue
+                partial = b''
+                m = FRAME_RE.search(line)
+                if m:
+                    key = (int(m.group(1), 16), int(m.group(2), 16))
+                    self.seen[key] = time.time()
+
+def schedule(frames, args):
+    """Yield (delay before sending, data) for every frame to send."""
+    if args.rate or args.ramp:
+        for _, data in frames:
+            yield None, data
+        return
+    prev = None
+    for timestamp, data in frames:
+        yield (0 if prev is None else (timestamp - prev) / args.speed), data
+        prev = timestamp
+
+class Run:
+    """Counters for one measurement window."""
+    def __init__(self, stats, rx):
+        self.stats = stats
+        self.rx = rx
+        self.base = dict(stats.stat) if stats.stat else None
+        if rx:
+            rx.seen.clear()
+        self.sent = {}
+        self.count = 0
+        self.start = time.time()
+        self.end = self.start
+
+    def send(self, port, data):
+        # Latency counts from the start of the write
+        now = time.time()
+        self.sent[frame_key(data)] = now
+        port.write(make_packet(data))
+        self.count += 1
+        self.end = now
+
+    def report(self, settle=1.0):
+        # Give the last frames time to make it through
+        time.sleep(settle)
+        elapsed = max(self.end - self.start, 1e-6)
+        r = {'sent': self.count, 'fps': self.count / elapsed}
+
+        if self.base and self.stats.stat:
+            d = {k: self.stats.stat[k] - self.base[k] for k in self.base}
+            on_air = d['adv'] + d['stream']
+            r.update({'parsed': d['frames'], 'uart_lost': self.count - d['frames'],
+                      'overflow': d['overflow'], 'on_air': on_air,
+                      'adv_lost': d['frames'] - on_air, 'congested': d['congested'],
+                      'on_air_fps': on_air / elapsed})
+
+        if self.rx:
+            latency = [(seen - self.sent[key]) * 1000
+                       for key, seen in list(self.rx.seen.items())
+                       if key in self.sent and seen >= self.sent[key]]
+            r['rendered'] = len(latency)
+            if 'on_air' in r:
+                r['scan_lost'] = r['on_air'] - len(latency)
+            if latency:
+                latency.sort()
+                r['latency'] = (statistics.mean(latency), latency[len(latency) // 2],
+                                latency[int(len(latency) * 0.95)], latency[-1])
+        return r
+
+def print_report(r):
+    print(f"sent {r['sent']} frames, {r['fps']:.1f} fps")
+    if 'parsed' in r:
+        print(f"  uart:  parsed {r['parsed']}, lost {r['uart_lost']} "
+              f"({r['overflow']} bytes overflowed)")
+        print(f"  adv:   on air {r['on_air']} ({r['on_air_fps']:.1f} fps), "
+              f"superseded {r['adv_lost']}, congested {r['congested']}")
+    else:
+        print('  tx:    no STAT from the transmitter')
+    if 'rendered' in r:
+        print(f"  scan:  rendered {r['rendered']}, lost {r.get('scan_lost', 'n/a')}")
+    if 'latency' in r:
+        print('  latency: mean {:.1f} p50 {:.1f} p95 {:.1f} max {:.1f} ms'.format(*r['latency']))
+
+def loss(r):
+    delivered = r.get('rendered', r.get('on_air', r['sent']))
+    return 1 - delivered / r['sent'] if r['sent'] else 0
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('trace')
+    parser.add_argument('--port', required=True, help='transmitter UART (or pty)')
+    parser.add_argument('--baudrate', type=int, default=115200)
+    parser.add_argument('--rx-log', help='receiver log to follow, for scan losses and latency')
+    mode = parser.add_mutually_exclusive_group()
+    mode.add_argument('--speed', type=float, default=1.0, help='play back N times faster')
+    mode.add_argument('--rate', type=float, help='ignore the trace timing, send at a fixed fps')
+    mode.add_argument('--ramp', help='START,STEP,SECONDS: raise the fps until frames drop')
+    parser.add_argument('--max-loss', type=float, default=0.05,
+                        help='loss ratio at which the ramp stops (default: %(default)s)')
+    parser.add_argument('--loops', type=int, default=1, help='times to play the trace (0: forever)')
+    args = parser.parse_args()
+
+    frames = read_trace(args.trace)
+    if not frames:
+        raise SystemExit(f'{args.trace}: no frames')
+    loops = itertools.repeat(frames, args.loops) if args.loops else itertools.repeat(frames)
+    frames = itertools.chain.from_iterable(loops)
+
+    port = serial.Serial(args.port, args.baudrate, timeout=1)
+    stats = StatReader(port)
+    stats.start()
+    rx = None
+    if args.rx_log:
+        rx = RxLogReader(args.rx_log)
+        rx.start()
+
+    # Warm up, and get the baseline for the transmitter counters
+    port.write(make_packet(next(frames)[1]))
+    if not stats.updated.wait(2):
+        print('no STAT from the transmitter, only host-side numbers are available')
+
+    seq = itertools.count(1)
+    plan = schedule(frames, args)
+
+    if not args.ramp:
+        run = Run(stats, rx)
+        interval = 1 / args.rate if args.rate else None
+        for delay, data in plan:
+            time.sleep(interval if interval else delay)
+            run.send(port, mark(data, next(seq)))
+        print_report(run.report())
+        return
+
+    fps, step, seconds = (float(x) for x in args.ramp.split(','))
+    best = None
+    while True:
+        run = Run(stats, rx)
+        deadline = time.time() + seconds
+        for _, data in plan:
+            run.send(port, mark(data, next(seq)))
+            if time.time() >= deadline:
+                break
+            time.sleep(max(0, run.start + run.count / fps - time.time()))
+        else:
+            print('trace exhausted, use --loops 0 to ramp')
+            break
+
+        r = run.report()
+        print(f'--- target {fps:.1f} fps')
+        print_report(r)
+        if loss(r) > args.max_loss:
+            break
+        best = r['fps']
+        fps += step
+
+    print(f"max sustained: {best:.1f} fps" if best else 'frames dropped at the first step')
+
+if __name__ == '__main__':
+    main()
@@ -2,11 +2,15 @@
 
 import jenkins
 import json
+import ijson
+import os
+import re
 import requests
 import enum
 import time
 import serial
 import struct
+from juletre_trace import TraceWriter, make_packet
 
 
 class NodeState(enum.IntEnum):
@@ -20,132 +24,144 @@ class LedFX(enum.IntEnum):
     FAST_BLINK = enum.auto()
     BREATHE = enum.auto()
 
-def get_queue(server):
-    qi = server.get_queue_info()
-    test = []
-    build = []
-    for job in qi:
-        why = job.get('why')
-        if 'Waiting for next' in why:
-            if 'test-ble' in why:
-                test += [job]
-            elif 'build-ncs' in why:
-                build += [job]
-    return {'queue': qi, 'test': test, 'build': build}
-
-# queue = get_queue(server)
-# print(f"Build queue: {len(queue['build'])}")
-# print(f"Test  queue: {len(queue['test'])}")
-
-def get_nodes_extrainfo(server, depth=0):
-    """Low-level method to return the whole node info structure
-    instead of just the name and status.
+def load_config(path):
+    """Load the segment config, see jenkins-tree.json for an example.
+
+    Segments are shown on the strip in the order they are listed. A node (or
+    queued job) is counted in the first segment it matches, so more specific
+    patterns go first.
+    """
+    with open(path) as f:
+        config = json.load(f)
+
+    for seg in config['segments']:
+        seg['effect'] = LedFX[seg.get('effect', 'SOLID')]
+        if seg['source'] == 'nodes':
+            seg['label'] = re.compile(seg['label'])
+            seg['name'] = re.compile(seg.get('name', ''))
+            seg['state'] = NodeState[seg['state'].upper()]
+        elif seg['source'] == 'queue':
+            seg['reason'] = re.compile(seg['reason'])
+        else:
+            raise ValueError(f"unknown segment source: {seg['source']}")
+
+    return config
+
+# Only ask Jenkins for the fields we use, it makes a big difference on large
+# farms.
+NODES_QUERY = 'computer/api/json?tree=computer[displayName,idle,offline,assignedLabels[name]]'
+QUEUE_QUERY = 'queue/api/json?tree=items[why]'
+
+def stream_json(server, query, prefix):
+    """Iterate over the items at `prefix` in the JSON answer to `query`,
+    without loading the whole document in memory.
     """
-    nodes_data = json.loads(server.jenkins_open(
-        requests.Request('GET', server._build_url(jenkins.NODE_LIST, locals()))))
-    return nodes_data["computer"]
-
-def extract_info(name, info):
-    idle = info['idle']
-    offline = info['offline']
-    if offline:
-        status = NodeState.OFFLINE
-    elif idle:
-        status = NodeState.IDLE
+    response = server.jenkins_request(
+        requests.Request('GET', server._build_url(query)), stream=True)
+    response.raw.decode_content = True
+    try:
+        yield from ijson.items(response.raw, prefix)
+    finally:
+        response.close()
+
+def node_state(node):
+    if node['offline']:
+        return NodeState.OFFLINE
+    elif node['idle']:
+        return NodeState.IDLE
     else:
-        status = NodeState.BUSY
-    return {'name': name, 'status': status}
-
-def get_nodes(server):
-    nodes_build = []
-    nodes_test = []
-    # st = time.time()
-    nodes = get_nodes_extrainfo(server)
-    # print(f'req time: {time.time() - st}')
+        return NodeState.BUSY
+
+def count_nodes(nodes, segments, counts):
+    segments = [(i, seg) for i, seg in enumerate(segments) if seg['source'] == 'nodes']
     for node in nodes:
-        try:
-            name = node['displayName']
-        except:
+        name = node.get('displayName')
+        if name is None:
             continue
-        if not (('build-' in name) or ('test-' in name)):
+        state = node_state(node)
+        labels = [label['name'] for label in node.get('assignedLabels', [])]
+        for i, seg in segments:
+            if (seg['state'] == state
+                    and seg['name'].search(name)
+                    and any(seg['label'].search(label) for label in labels)):
+                counts[i] += 1
+                break
+
+def count_queue(reasons, segments, counts):
+    segments = [(i, seg) for i, seg in enumerate(segments) if seg['source'] == 'queue']
+    for why in reasons:
+        if why is None:
             continue
-        info = node
-        labels = info['assignedLabels']
-        for label in labels:
-            if 'build-ncs' in label['name']:
-                nodes_build += [extract_info(name, info)]
-            if 'node-test-ble' in label['name']:
-                nodes_test += [extract_info(name, info)]
-    return {'build': nodes_build, 'test': nodes_test}
-
-
-# nodes = get_nodes(server)
-
-def nodes_with_state(nodes, state: NodeState):
-    return [node for node in nodes if node['status'] == state]
-
-def build_report(name, nodes):
-    busy = nodes_with_state(nodes, NodeState.BUSY)
-    idle = nodes_with_state(nodes, NodeState.IDLE)
-    offline = nodes_with_state(nodes, NodeState.OFFLINE)
-    print(f'\n{name} nodes: ')
-    print(f'busy: {len(busy)}')
-    print(f'idle: {len(idle)}')
-    print(f'offline: {len(offline)}')
-
-# build_report("Build", nodes['build'])
-# build_report("Test", nodes['test'])
-
-C_RED = [0xff, 0x00, 0x00]
-C_PURPLE = [0xc1, 0x2a, 0xb4]
-C_YELLOW = [0xff, 0xd9, 0x00]
-C_GREEN = [0x00, 0x20, 0x00]
-# C_BLUE = [0x2c, 0xe8, 0x00]
+        for i, seg in segments:
+            if seg['reason'].search(why):
+                counts[i] += 1
+                break
+
+def get_counts(server, segments):
+    """Count nodes and queued jobs per segment, in a single pass over each."""
+    counts = [0] * len(segments)
+    count_nodes(stream_json(server, NODES_QUERY, 'computer.item'), segments, counts)
+    count_queue(stream_json(server, QUEUE_QUERY, 'items.item.why'), segments, counts)
+    return counts
+
+def scale_counts(counts, leds):
+    """Scale the counts down proportionally if they don't fit on the strip."""
+    total = sum(counts)
+    if total <= leds:
+        return counts
+
+    # Largest remainder: round down, then hand out the leftover LEDs to the
+    # segments that lost the most in the rounding.
+    scaled = [(c * leds) // total for c in counts]
+    order = sorted(range(len(counts)),
+                   key=lambda i: (counts[i] * leds) % total, reverse=True)
+    for i in order[:leds - sum(scaled)]:
+        scaled[i] += 1
+    return scaled
 
 def make_leds(color, effect, n):
     data = bytes(color) + struct.pack('B', effect)
     return data * n
 
-def build_led_string(nodes, queue):
-    busy_test = len(nodes_with_state(nodes['test'], NodeState.BUSY))
-    idle_test = len(nodes_with_state(nodes['test'], NodeState.IDLE))
-    wait_test = len(queue['test'])
-    wait_build = len(queue['build'])
-
-    print('busy test: {} idle test: {} wait test: {} wait build: {}'.format(
-        busy_test, idle_test, wait_test, wait_build))
+def build_led_string(segments, counts, leds):
+    print(' '.join(f"{seg.get('desc', i)}: {c}" for i, (seg, c) in enumerate(zip(segments, counts))))
 
-    return (make_leds(C_RED, LedFX.FAST_BLINK, busy_test)
-            + make_leds(C_YELLOW, LedFX.FAST_BLINK, idle_test)
-            + make_leds(C_PURPLE, LedFX.BREATHE, wait_test)
-            + make_leds(C_GREEN, LedFX.SOLID, wait_build))
+    return b''.join(make_leds(seg['color'], seg['effect'], n)
+                    for seg, n in zip(segments, scale_counts(counts, leds)))
 
-def send_data(data):
-    # There's a bug here (or somewhere else): the tree doesn't light up all the
-    # way to the top, it's missing a few leds
-    if len(data) > (68 * 4):
-        data = data[:(68*4) - 1]
-    header = b'UART' + struct.pack('H', len(data)) + b'\0'
-    # print(f'Header: {header.hex(" ")} Data: {data.hex(" ")}')
-    port.write(header + data)
+def send_data(data, leds):
+    # Don't send more than the strip can show, and never cut an LED in half
+    data = data[:leds * 4]
+    packet = make_packet(data)
+    # print(f'Packet: {packet.hex(" ")}')
+    port.write(packet)
+    if trace:
+        trace.write(data)
 
 
 
 # Main refresh loop
-while True:
-    try:
-        port = serial.Serial('/dev/serial/by-id/usb-SEGGER_J-Link_000682108520-if00', 115200, timeout=1)
-        server = jenkins.Jenkins("https://my-jenkins-install.local/",
-                                username="my-user",
-                                password="my-token")
-
-        while True:
-            queue = get_queue(server)
-            nodes = get_nodes(server)
-            send_data(build_led_string(nodes, queue))
-            time.sleep(5)
-    except Exception as e:
-        # Don't need to close the server?
-        port.close()
-        if e is KeyboardInterrupt:
-            exit(0)
+if __name__ == '__main__':
+    config = load_config(os.environ.get('JULETRE_CONFIG',
+                                        os.path.join(os.path.dirname(__file__), 'jenkins-tree.json')))
+    # Record everything that is sent, to be played back with jenkins-replay.py
+    trace_path = os.environ.get('JULETRE_TRACE', config.get('trace'))
+    trace = TraceWriter(trace_path) if trace_path else None
+
+    while True:
+        try:
+            port = serial.Serial(config['serial'], 115200, timeout=1)
+            server = jenkins.Jenkins(config['jenkins']['url'],
+                                    username=config['jenkins']['username'],
+                                    password=config['jenkins']['password'])
+
+            while True:
+                counts = get_counts(server, config['segments'])
+                send_data(build_led_string(config['segments'], counts, config['leds']),
+                          config['leds'])
+                time.sleep(config.get('interval', 5))
+        except Exception as e:
+            # Don't need to close the server?
+            port.close()
+            if e is KeyboardInterrupt:
+                exit(0)
@@ -0,0 +1,51 @@
+"""Frame trace format shared by jenkins-tree.py and jenkins-replay.py.
+
+A trace is a text file with a header line, then one frame per line: the host
+time it was sent (seconds since the epoch) and the frame payload in hex, as
+passed to send_data().
+
+    # juletre-trace 1
+    1702483200.123456 ff000002ff000002...
+"""
+
+import os
+import struct
+import time
+
+TRACE_HEADER = '# juletre-trace 1'
+
+def make_packet(data):
+    """Wrap a frame in the header expected by the transmitter UART parser."""
+    return b'UART' + struct.pack('H', len(data)) + b'\0' + data
+
+class TraceWriter:
+    def __init__(self, path):
+        new = not os.path.exists(path) or os.path.getsize(path) == 0
+        self.file = open(path, 'a')
+        if new:
+            self.file.write(TRACE_HEADER + '\n')
+
+    def write(self, data, timestamp=None):
+        if timestamp is None:
+            timestamp = time.time()
+        self.file.write(f'{timestamp:.6f} {data.hex()}\n')
+        self.file.flush()
+
+    def close(self):
+        self.file.close()
+
+def read_trace(path):
+    """Return the frames of a trace as a list of (timestamp, data)."""
+    frames = []
+    with open(path) as f:
+        if f.readline().strip() != TRACE_HEADER:
+            raise ValueError(f'{path}: not a juletre trace')
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            # Empty frames (nothing to show) have no data field
+            parts = line.split()
+            data = bytes.fromhex(parts[1]) if len(parts) > 1 else b''
+            frames.append((float(parts[0]), data))
+    return frames
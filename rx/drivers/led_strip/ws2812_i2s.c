@@ -24,6 +24,8 @@ LOG_MODULE_REGISTER(ws2812_i2s);
 #include <zephyr/dt-bindings/led/led.h>
 
 #define WS2812_I2S_PRE_DELAY_WORDS 1
+/* Duration of one (stereo) I2S frame at 100kHz LRCK */
+#define WS2812_I2S_WORD_US 10
 
 struct ws2812_i2s_cfg {
     struct device const *dev;
@@ -31,8 +33,11 @@ struct ws2812_i2s_cfg {
     struct k_mem_slab *mem_slab;
     uint8_t num_colors;
     const uint8_t *color_mapping;
-    uint16_t reset_words;
-    bool active_low;
+    size_t length;
+    /* I2S nibbles for the WS2812 symbols, depending on the output polarity */
+    uint8_t sym_one;
+    uint8_t sym_zero;
+    uint32_t reset_word;
 };
 
 /* Serialize an 8-bit clor channel value into two 16-bit I2S words (or 1 32-bit
@@ -54,73 +59,45 @@ static inline void ws2812_i2s_ser(uint32_t *word, uint8_t color,
     *word = (*word >> 16) | (*word << 16);
 }
 
-static int ws2812_strip_update_rgb(const struct device *dev,
-                                   struct led_rgb *pixels,
-                                   size_t num_pixels)
+/* Get a TX block with the pre-data reset already written. Returns a pointer to
+ * where the first channel goes.
+ */
+static uint32_t *ws2812_i2s_begin(const struct ws2812_i2s_cfg *cfg,
+                                  void **mem_block)
 {
-    const struct ws2812_i2s_cfg *cfg = dev->config;
-    uint8_t sym_one, sym_zero;
-    uint32_t reset_word;
     uint32_t *tx_buf;
-    void *mem_block;
     int ret;
 
-    if(cfg->active_low) {
-        sym_one = 0x1;
-        sym_zero = 0x7;
-        reset_word = 0xFFFFFFFF;
-    } else {
-        sym_one = 0xE;
-        sym_zero = 0x8;
-        reset_word = 0;
-    }
-
     /* Acquire memory for the I2S payload. */
-    ret = k_mem_slab_alloc(cfg->mem_slab, &mem_block, K_SECONDS(10));
+    ret = k_mem_slab_alloc(cfg->mem_slab, mem_block, K_SECONDS(10));
     if (ret < 0) {
         LOG_ERR("Unable to allocate mem slab for TX (err %d)", ret);
-        return -ENOMEM;
+        return NULL;
     }
-    tx_buf = (uint32_t*)mem_block;
+    tx_buf = (uint32_t*)*mem_block;
 
     /* Add a pre-data reset, so the first pixel isn't skipped by the strip. */
     for(uint16_t i = 0; i < WS2812_I2S_PRE_DELAY_WORDS; i++) {
-        *tx_buf = reset_word;
+        *tx_buf = cfg->reset_word;
         tx_buf++;
     }
 
-    /*
-     * Convert pixel data into I2S frames. Each frame has pixel data
-     * in color mapping on-wire format (e.g. GRB, GRBW, RGB, etc).
-     */
-    for (uint16_t i = 0; i < num_pixels; i++) {
-        for (uint16_t j = 0; j < cfg->num_colors; j++) {
-            uint8_t pixel;
-
-            switch (cfg->color_mapping[j]) {
-                /* White channel is not supported by LED strip API. */
-                case LED_COLOR_ID_WHITE:
-                    pixel = 0;
-                    break;
-                case LED_COLOR_ID_RED:
-                    pixel = pixels[i].r;
-                    break;
-                case LED_COLOR_ID_GREEN:
-                    pixel = pixels[i].g;
-                    break;
-                case LED_COLOR_ID_BLUE:
-                    pixel = pixels[i].b;
-                    break;
-                default:
-                    return -EINVAL;
-            }
-            ws2812_i2s_ser(tx_buf, pixel, sym_one, sym_zero);
-            tx_buf++;
-        }
-    }
+    return tx_buf;
+}
 
-    for(uint16_t i = 0; i < cfg->reset_words; i++) {
-        *tx_buf = reset_word;
+/* Fill the rest of the block with reset words and send it out. */
+static int ws2812_i2s_flush(const struct ws2812_i2s_cfg *cfg,
+                            void *mem_block, uint32_t *tx_buf)
+{
+    uint32_t *tx_end = (uint32_t*)((uint8_t*)mem_block + cfg->tx_buf_bytes);
+    int ret;
+
+    /* The block is sized for the whole chain. On a short update this just
+     * makes the reset period longer: pixels past the ones written get no data
+     * and keep their previous color.
+     */
+    while (tx_buf < tx_end) {
+        *tx_buf = cfg->reset_word;
         tx_buf++;
     }
 
@@ -144,19 +121,81 @@ static int ws2812_strip_update_rgb(const struct device *dev,
         return ret;
     }
 
-    /* FIXME: calculate this correctly. */
-    /* capture says around ~3ms max */
-    k_msleep(500);
+    /* Wait for the block to drain before the next update can be queued. Each
+     * 32-bit word is one 10us I2S frame, plus some margin for the driver to
+     * go back to the READY state.
+     */
+    k_usleep(WS2812_I2S_WORD_US * (cfg->tx_buf_bytes / 4) + 1000);
 
     return ret;
 }
 
+static int ws2812_strip_update_rgb(const struct device *dev,
+                                   struct led_rgb *pixels,
+                                   size_t num_pixels)
+{
+    const struct ws2812_i2s_cfg *cfg = dev->config;
+    uint32_t *tx_buf;
+    void *mem_block;
+
+    if (num_pixels > cfg->length) {
+        return -EINVAL;
+    }
+
+    tx_buf = ws2812_i2s_begin(cfg, &mem_block);
+    if (!tx_buf) {
+        return -ENOMEM;
+    }
+
+    /*
+     * Convert pixel data into I2S frames. Each frame has pixel data
+     * in color mapping on-wire format (e.g. GRB, GRBW, RGB, etc).
+     */
+    for (uint16_t i = 0; i < num_pixels; i++) {
+        /* Indexed by color ID, the mapping was validated at init. White
+         * channel is not supported by LED strip API.
+         */
+        const uint8_t colors[] = {
+            [LED_COLOR_ID_WHITE] = 0,
+            [LED_COLOR_ID_RED] = pixels[i].r,
+            [LED_COLOR_ID_GREEN] = pixels[i].g,
+            [LED_COLOR_ID_BLUE] = pixels[i].b,
+        };
+
+        for (uint16_t j = 0; j < cfg->num_colors; j++) {
+            ws2812_i2s_ser(tx_buf, colors[cfg->color_mapping[j]],
+                           cfg->sym_one, cfg->sym_zero);
+            tx_buf++;
+        }
+    }
+
+    return ws2812_i2s_flush(cfg, mem_block, tx_buf);
+}
+
+/* Channels are expected in on-wire order (e.g. GRB), and are serialized as-is. */
 static int ws2812_strip_update_channels(const struct device *dev,
                                         uint8_t *channels,
                                         size_t num_channels)
 {
-    LOG_ERR("update_channels not implemented");
-    return -ENOTSUP;
+    const struct ws2812_i2s_cfg *cfg = dev->config;
+    uint32_t *tx_buf;
+    void *mem_block;
+
+    if (num_channels > cfg->length * cfg->num_colors) {
+        return -EINVAL;
+    }
+
+    tx_buf = ws2812_i2s_begin(cfg, &mem_block);
+    if (!tx_buf) {
+        return -ENOMEM;
+    }
+
+    for (size_t i = 0; i < num_channels; i++) {
+        ws2812_i2s_ser(tx_buf, channels[i], cfg->sym_one, cfg->sym_zero);
+        tx_buf++;
+    }
+
+    return ws2812_i2s_flush(cfg, mem_block, tx_buf);
 }
 
 static int ws2812_i2s_init(const struct device *dev)
@@ -216,6 +255,13 @@ static const struct led_strip_driver_api ws2812_i2s_api = {
 #define WS2812_I2S_NUM_PIXELS(idx)              \
     (DT_INST_PROP(idx, chain_length))
 
+#define WS2812_I2S_SYM_ONE(idx)                                     \
+    (DT_INST_PROP(idx, out_active_low) ? 0x1 : 0xE)
+#define WS2812_I2S_SYM_ZERO(idx)                                    \
+    (DT_INST_PROP(idx, out_active_low) ? 0x7 : 0x8)
+#define WS2812_I2S_RESET_WORD(idx)                                  \
+    (DT_INST_PROP(idx, out_active_low) ? 0xFFFFFFFF : 0)
+
 #define WS2812_I2S_BUFSIZE(idx)                                     \
     ((WS2812_NUM_COLORS(idx) * WS2812_I2S_NUM_PIXELS(idx)           \
       + WS2812_I2S_PRE_DELAY_WORDS                                  \
@@ -236,8 +282,10 @@ static const struct led_strip_driver_api ws2812_i2s_api = {
     .mem_slab = &ws2812_i2s_##idx##_slab,                               \
     .num_colors = WS2812_NUM_COLORS(idx),                               \
     .color_mapping = ws2812_i2s_##idx##_color_mapping,                  \
-    .reset_words = WS2812_RESET_DELAY_WORDS(idx),                       \
-    .active_low = DT_INST_PROP(idx, out_active_low),                    \
+    .length = WS2812_I2S_NUM_PIXELS(idx),                               \
+    .sym_one = WS2812_I2S_SYM_ONE(idx),                                 \
+    .sym_zero = WS2812_I2S_SYM_ZERO(idx),                               \
+    .reset_word = WS2812_I2S_RESET_WORD(idx),                           \
 };                                                                      \
                                                                         \
     DEVICE_DT_INST_DEFINE(idx,                                          \
@@ -0,0 +1,68 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include "bench.h"
+#include "led.h"
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(bench, 1);
+
+#define WINDOW_MS 1000
+
+/* Headless stand-in for led.c: there is no strip to drive in the simulation,
+ * frames are accounted for as they are committed instead.
+ */
+void led_register_data(struct led_data *array, uint16_t len) {}
+void led_thread_start(void) {}
+void led_idle_animation(bool use_idle) {}
+void led_data_lock(void) {}
+void led_data_unlock(void) {}
+
+static uint32_t last_seq;
+static int64_t window_start;
+static uint32_t frames;
+static uint32_t lost;
+static uint64_t latency_sum;
+static uint32_t latency_max;
+
+void bench_frame(const uint8_t *data, uint16_t len)
+{
+	uint32_t now_us = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+	uint32_t seq, sent_us, latency;
+
+	if (len < 8) {
+		return;
+	}
+
+	seq = sys_get_le32(&data[0]);
+	sent_us = sys_get_le32(&data[4]);
+
+	if (seq <= last_seq) {
+		/* Repeat, or the transmitter restarted */
+		if (seq == last_seq) {
+			return;
+		}
+	} else if (last_seq) {
+		lost += seq - last_seq - 1;
+	}
+	last_seq = seq;
+
+	latency = now_us - sent_us;
+	latency_sum += latency;
+	latency_max = MAX(latency_max, latency);
+	frames++;
+
+	if (!window_start) {
+		window_start = k_uptime_get();
+	}
+
+	if (k_uptime_get() - window_start >= WINDOW_MS) {
+		printk("bench: %u frames/s lost %u latency avg %u us max %u us\n",
+		       frames, lost, (uint32_t)(latency_sum / frames), latency_max);
+		frames = 0;
+		lost = 0;
+		latency_sum = 0;
+		latency_max = 0;
+		window_start = k_uptime_get();
+	}
+}
@@ -0,0 +1,9 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+
+/* Account for a frame from a JULETRE_BENCH transmitter, as it is committed. */
+void bench_frame(const uint8_t *data, uint16_t len);
+
+#endif // BENCH_H_
@@ -0,0 +1,79 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include "frame.h"
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(frame, 1);
+
+static void reasm_start(struct frame_reasm *reasm, uint8_t seq,
+			uint16_t len, uint16_t crc)
+{
+	reasm->active = true;
+	reasm->committed = false;
+	reasm->seq = seq;
+	reasm->len = len;
+	reasm->crc = crc;
+	reasm->received = 0;
+	memset(reasm->have, 0, sizeof(reasm->have));
+}
+
+bool frame_reasm_add(struct frame_reasm *reasm, const uint8_t *chunk, uint16_t len)
+{
+	const struct frame_hdr *hdr = (const struct frame_hdr *)chunk;
+	uint16_t offset, frame_len, crc;
+
+	if (len < sizeof(*hdr)) {
+		LOG_DBG("runt chunk: %u", len);
+		return false;
+	}
+
+	offset = sys_le16_to_cpu(hdr->offset);
+	frame_len = sys_le16_to_cpu(hdr->len);
+	crc = sys_le16_to_cpu(hdr->crc);
+	chunk += sizeof(*hdr);
+	len -= sizeof(*hdr);
+
+	if (frame_len == 0 || frame_len > FRAME_MAX_LEN ||
+	    offset + len > frame_len) {
+		LOG_DBG("bad chunk: off %u len %u frame %u", offset, len, frame_len);
+		return false;
+	}
+
+	if (reasm->committed && hdr->seq == reasm->seq && crc == reasm->crc) {
+		/* Repeat of the frame that is already shown */
+		return false;
+	}
+
+	if (!reasm->active || hdr->seq != reasm->seq ||
+	    frame_len != reasm->len || crc != reasm->crc) {
+		/* Start of a new frame. Anything left of the previous one is
+		 * never going to be completed.
+		 */
+		reasm_start(reasm, hdr->seq, frame_len, crc);
+	}
+
+	memcpy(&reasm->buf[offset], chunk, len);
+	for (uint16_t i = offset; i < offset + len; i++) {
+		if (!(reasm->have[i / 8] & BIT(i % 8))) {
+			reasm->have[i / 8] |= BIT(i % 8);
+			reasm->received++;
+		}
+	}
+
+	if (reasm->received < reasm->len) {
+		return false;
+	}
+
+	reasm->active = false;
+
+	if (crc16_itu_t(0xffff, reasm->buf, reasm->len) != reasm->crc) {
+		LOG_ERR("frame %u: bad crc", reasm->seq);
+		return false;
+	}
+
+	reasm->committed = true;
+	return true;
+}
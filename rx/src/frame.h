@@ -0,0 +1,38 @@
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+/* Largest frame we reassemble: one led_data per LED */
+#define FRAME_MAX_LEN (68 * 4)
+
+/* Prepended to each chunk of a frame in the advertising data. Little-endian,
+ * must match tx/src/frame.h.
+ */
+struct frame_hdr {
+	uint8_t seq;		/* Incremented for every frame */
+	uint16_t offset;	/* Of this chunk in the frame */
+	uint16_t len;		/* Of the whole frame */
+	uint16_t crc;		/* CRC-16/CCITT (0xffff seed) of the whole frame */
+} __packed;
+
+/* Collects the chunks of a frame, possibly over several advertising reports. */
+struct frame_reasm {
+	bool active;		/* Chunks of `seq` are being collected */
+	bool committed;		/* `seq` was complete and valid */
+	uint8_t seq;
+	uint16_t len;
+	uint16_t crc;
+	uint16_t received;	/* Number of distinct bytes received */
+	uint8_t have[DIV_ROUND_UP(FRAME_MAX_LEN, 8)];
+	uint8_t buf[FRAME_MAX_LEN];
+};
+
+/* Add a chunk (header included). Returns true once the frame is complete and
+ * its CRC checks out, `buf` then holds `len` bytes of frame data.
+ */
+bool frame_reasm_add(struct frame_reasm *reasm, const uint8_t *chunk, uint16_t len);
+
+#endif // FRAME_H_
@@ -2,6 +2,7 @@
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/led_strip.h>
+#include <zephyr/dt-bindings/led/led.h>
 
 #include "led.h"
 #include "i2s_led.h"
@@ -14,12 +15,34 @@ static bool idle;
 #define LED_PRIORITY K_PRIO_PREEMPT(0)
 #define STRIP_NODE DT_ALIAS(led_strip)
 #define STRIP_NUM_PIXELS DT_PROP(DT_ALIAS(led_strip), chain_length)
+#define STRIP_NUM_COLORS DT_PROP_LEN(STRIP_NODE, color_mapping)
 
-struct led_rgb pixels[STRIP_NUM_PIXELS];
+/* Offset in struct led_data of each on-wire channel, from the color-mapping
+ * DT property. Frames carry no white channel.
+ */
+#define LED_DATA_OFFSET(id)                                             \
+    ((id) == LED_COLOR_ID_RED ? offsetof(struct led_data, r) :          \
+     (id) == LED_COLOR_ID_GREEN ? offsetof(struct led_data, g) :        \
+     offsetof(struct led_data, b))
+#define CHANNEL_OFFSET(node_id, prop, idx)                              \
+    LED_DATA_OFFSET(DT_PROP_BY_IDX(node_id, prop, idx)),
+#define CHANNEL_CHECK(node_id, prop, idx)                               \
+    BUILD_ASSERT(DT_PROP_BY_IDX(node_id, prop, idx) != LED_COLOR_ID_WHITE, \
+                 "white channel is not supported");
+
+DT_FOREACH_PROP_ELEM(STRIP_NODE, color_mapping, CHANNEL_CHECK)
+
+static const uint8_t channel_offset[STRIP_NUM_COLORS] = {
+    DT_FOREACH_PROP_ELEM(STRIP_NODE, color_mapping, CHANNEL_OFFSET)
+};
+
+/* Strip contents, in on-wire order (e.g. GRB) */
+static uint8_t channels[STRIP_NUM_PIXELS * STRIP_NUM_COLORS];
 
 static const struct device *strip = DEVICE_DT_GET(STRIP_NODE);
 
 K_SEM_DEFINE(data_updated, 0, 1);
+K_MUTEX_DEFINE(data_lock);
 
 void led_entry_point(void *p1, void *p2, void *p3)
 {
@@ -28,25 +51,26 @@ void led_entry_point(void *p1, void *p2, void *p3)
     ARG_UNUSED(p3);
 
     while (true) {
+        k_sem_take(&data_updated, K_FOREVER);
+
         if (idle) {
             /* TODO: show idle animation */
-            for (int i=0; i<STRIP_NUM_PIXELS; i++) {
-                pixels[i].r = 0;
-                pixels[i].g = 0;
-                pixels[i].b = 0;
-            }
+            memset(channels, 0, sizeof(channels));
         } else {
-            k_sem_take(&data_updated, K_FOREVER);
             /* read out array and set led data colors */
             /* TODO: respect effect flag */
+            uint8_t *ch = channels;
+
+            k_mutex_lock(&data_lock, K_FOREVER);
             for (int i=0; i<STRIP_NUM_PIXELS; i++) {
-                pixels[i].r = data[i].r;
-                pixels[i].g = data[i].g;
-                pixels[i].b = data[i].b;
+                for (int j=0; j<STRIP_NUM_COLORS; j++) {
+                    *ch++ = ((uint8_t *)&data[i])[channel_offset[j]];
+                }
             }
+            k_mutex_unlock(&data_lock);
         }
 
-        int rc = led_strip_update_rgb(strip, pixels, STRIP_NUM_PIXELS);
+        int rc = led_strip_update_channels(strip, channels, sizeof(channels));
         if (rc) {
             printk("couldn't update strip: %d", rc);
         }
@@ -79,6 +103,16 @@ void led_thread_start(void)
 
 void led_idle_animation(bool use_idle)
 {
-    k_sem_give(&data_updated);
     idle = use_idle;
+    k_sem_give(&data_updated);
+}
+
+void led_data_lock(void)
+{
+    k_mutex_lock(&data_lock, K_FOREVER);
+}
+
+void led_data_unlock(void)
+{
+    k_mutex_unlock(&data_lock);
 }
@@ -19,4 +19,10 @@ void led_thread_start(void);
 
 void led_idle_animation(bool use_idle);
 
+/* Hold while writing to the registered array, so a frame is never rendered
+ * half-updated.
+ */
+void led_data_lock(void);
+void led_data_unlock(void);
+
 #endif // LED_H_
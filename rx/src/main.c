@@ -3,6 +3,8 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/bluetooth/bluetooth.h>
 #include "led.h"
+#include "sources.h"
+#include "stream.h"
 
 #include <zephyr/logging/log.h>
 
@@ -17,8 +19,10 @@ static struct led_data strip[NUM_LEDS];
 /* The devicetree node identifier for the "led0" alias. */
 #define LED0_NODE DT_ALIAS(led0)
 
-#define HAS_LED     1
+#define HAS_LED     DT_NODE_HAS_STATUS(LED0_NODE, okay)
+#if HAS_LED
 static const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(LED0_NODE, gpios);
+#endif
 #define BLINK_ONOFF K_MSEC(500)
 
 static struct k_work_delayable blink_work;
@@ -27,7 +31,9 @@ static bool                  led_is_on;
 static void blink_timeout(struct k_work *work)
 {
 	led_is_on = !led_is_on;
+#if HAS_LED
 	gpio_pin_set(led.port, led.pin, (int)led_is_on);
+#endif
 }
 
 static bool data_cb(struct bt_data *data, void *user_data)
@@ -47,25 +53,36 @@ static bool data_cb(struct bt_data *data, void *user_data)
 	}
 }
 
+static void stream_frame(const uint8_t *data, uint16_t len)
+{
+	struct source *src = source_find(CONFIG_JULETRE_STREAM_SOURCE);
+
+	if (src) {
+		source_update(src, data, len);
+	}
+}
+
 static bool led_data_cb(struct bt_data *data, void *user_data)
 {
+	struct source *src = user_data;
+
 	switch (data->type) {
 	case BT_DATA_MANUFACTURER_DATA:
 		LOG_HEXDUMP_DBG(data->data, data->data_len, "ad data");
-		memset((uint8_t*)strip, 0, sizeof(strip));
-		memcpy((uint8_t*)strip, data->data, MIN(data->data_len, sizeof(strip)));
-		return false;
+		/* The frame is split over several elements */
+		source_add_chunk(src, data->data, data->data_len);
+		return true;
 	default:
 		return true;
 	}
 }
 
-#define PEER_NAME "santa"
 static void scan_recv(const struct bt_le_scan_recv_info *info,
 		      struct net_buf_simple *buf)
 {
 	char le_addr[BT_ADDR_LE_STR_LEN];
 	char name[NAME_LEN];
+	struct source *src;
 
 	/* if (info->rssi < -60) return; */
 
@@ -78,7 +95,8 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 	net_buf_simple_restore(buf, &state);
 
 	bt_addr_le_to_str(info->addr, le_addr, sizeof(le_addr));
-	if (strncmp(PEER_NAME, name, strlen(PEER_NAME))) {
+	src = source_find(name);
+	if (!src) {
 		return;
 	}
 
@@ -87,11 +105,8 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 	       le_addr, info->adv_type, info->tx_power, info->rssi, name,
 	       info->interval, info->interval * 5 / 4, buf->len);
 
-	bt_data_parse(buf, led_data_cb, NULL);
-	/* Switch to using received data */
-	/* TODO: switch it back after a timeout. */
+	bt_data_parse(buf, led_data_cb, src);
 	printk("got adv\n");
-	led_idle_animation(false);
 
 	k_work_schedule(&blink_work, BLINK_ONOFF);
 }
@@ -114,9 +129,12 @@ void main(void)
 	led_register_data(strip, NUM_LEDS);
 	led_idle_animation(true);
 	led_thread_start();
+	sources_init(strip, NUM_LEDS);
 
 	/* Configure on-board LED */
+#if HAS_LED
 	err = gpio_pin_configure_dt(&led, GPIO_OUTPUT_ACTIVE);
+#endif
 	k_work_init_delayable(&blink_work, blink_timeout);
 
 	/* Initialize the Bluetooth Subsystem */
@@ -138,5 +156,15 @@ void main(void)
 	}
 	printk("success.\n");
 
+	if (IS_ENABLED(CONFIG_JULETRE_STREAM)) {
+		printk("Start streaming server...");
+		err = stream_init(stream_frame, sizeof(strip));
+		if (err) {
+			printk("failed (err %d)\n", err);
+			return;
+		}
+		printk("success.\n");
+	}
+
 	return;
 }
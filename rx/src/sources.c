@@ -0,0 +1,188 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/crc.h>
+#include "bench.h"
+#include "frame.h"
+#include "sources.h"
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(sources, 1);
+
+#define SOURCE_TIMEOUT_MS CONFIG_JULETRE_SOURCE_TIMEOUT_MS
+#define CHECK_INTERVAL K_SECONDS(1)
+
+struct source {
+	const char *name;
+	uint16_t first;		/* First LED owned by this source */
+	uint16_t count;		/* Number of LEDs owned by this source */
+	int64_t last_seen;	/* Uptime of the last frame, 0 if stale */
+	struct frame_reasm reasm;
+};
+
+#define SOURCE(_name, _first, _count) \
+	{ .name = _name, .first = _first, .count = _count }
+
+#define SOURCES_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(juletre_sources)
+#define SOURCE_DT(node_id) \
+	SOURCE(DT_PROP(node_id, peer_name), DT_PROP(node_id, first_led), \
+	       DT_PROP(node_id, num_leds)),
+
+/* Sources come from the "juletre,sources" node in the board overlay. Without
+ * one, a single transmitter named "santa" owns the whole strip.
+ */
+static struct source sources[] = {
+#if DT_NODE_EXISTS(SOURCES_NODE)
+	DT_FOREACH_CHILD(SOURCES_NODE, SOURCE_DT)
+#else
+	SOURCE("santa", 0, 68),
+#endif
+};
+
+static struct led_data *strip;
+
+static struct k_work_delayable timeout_work;
+
+static void source_clear(struct source *src)
+{
+	memset(&strip[src->first], 0, src->count * sizeof(*strip));
+	src->last_seen = 0;
+}
+
+static void check_timeouts(struct k_work *work)
+{
+	int64_t now = k_uptime_get();
+	bool expired = false;
+	bool fresh = false;
+
+	led_data_lock();
+
+	for (int i = 0; i < ARRAY_SIZE(sources); i++) {
+		struct source *src = &sources[i];
+
+		if (!src->last_seen) {
+			continue;
+		}
+
+		if (now - src->last_seen > SOURCE_TIMEOUT_MS) {
+			printk("source %s timed out\n", src->name);
+			source_clear(src);
+			expired = true;
+		} else {
+			fresh = true;
+		}
+	}
+
+	led_data_unlock();
+
+	if (expired) {
+		/* Go back to the idle animation when nobody is talking to us */
+		led_idle_animation(!fresh);
+	}
+
+	k_work_schedule(&timeout_work, CHECK_INTERVAL);
+}
+
+int sources_init(struct led_data *array, uint16_t len)
+{
+	if (!array) {
+		return -EINVAL;
+	}
+
+	strip = array;
+
+	for (int i = 0; i < ARRAY_SIZE(sources); i++) {
+		struct source *src = &sources[i];
+
+		if (src->first >= len) {
+			LOG_ERR("%s: range starts past the strip", src->name);
+			src->count = 0;
+		} else if (src->first + src->count > len) {
+			LOG_ERR("%s: range truncated to the strip", src->name);
+			src->count = len - src->first;
+		}
+	}
+
+	/* Overlapping sources would overwrite each other's LEDs */
+	for (int i = 0; i < ARRAY_SIZE(sources); i++) {
+		for (int j = i + 1; j < ARRAY_SIZE(sources); j++) {
+			struct source *a = &sources[i];
+			struct source *b = &sources[j];
+
+			if (a->count && b->count &&
+			    a->first < b->first + b->count &&
+			    b->first < a->first + a->count) {
+				LOG_ERR("%s and %s: ranges overlap", a->name, b->name);
+			}
+		}
+	}
+
+	k_work_init_delayable(&timeout_work, check_timeouts);
+	k_work_schedule(&timeout_work, CHECK_INTERVAL);
+
+	return 0;
+}
+
+struct source *source_find(const char *name)
+{
+	for (int i = 0; i < ARRAY_SIZE(sources); i++) {
+		if (!strcmp(sources[i].name, name)) {
+			return &sources[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Frames are tagged in the log, so the host replay tool can tell which of the
+ * frames it sent made it all the way to the strip, and when. The tool puts a
+ * sequence number in the effect bytes of the first two LEDs.
+ */
+static void log_frame(const uint8_t *data, uint16_t len, uint16_t crc)
+{
+	uint16_t seq = len >= 8 ? data[3] | (data[7] << 8) : 0;
+
+	if (IS_ENABLED(CONFIG_JULETRE_REPLAY_STATS)) {
+		printk("frame %04x %04x\n", crc, seq);
+	}
+}
+
+static void source_apply(struct source *src, const uint8_t *data, uint16_t len)
+{
+	size_t range_len = src->count * sizeof(*strip);
+
+	led_data_lock();
+
+	memset(&strip[src->first], 0, range_len);
+	memcpy(&strip[src->first], data, MIN(len, range_len));
+	src->last_seen = k_uptime_get();
+
+	led_data_unlock();
+
+	if (IS_ENABLED(CONFIG_JULETRE_BENCH)) {
+		bench_frame(data, len);
+	}
+
+	/* Switch to using received data */
+	led_idle_animation(false);
+}
+
+void source_update(struct source *src, const uint8_t *data, uint16_t len)
+{
+	if (IS_ENABLED(CONFIG_JULETRE_REPLAY_STATS)) {
+		log_frame(data, len, crc16_itu_t(0xffff, data, len));
+	}
+
+	source_apply(src, data, len);
+}
+
+void source_add_chunk(struct source *src, const uint8_t *chunk, uint16_t len)
+{
+	/* Only called from the BT RX thread, no locking needed */
+	if (frame_reasm_add(&src->reasm, chunk, len)) {
+		/* Already checked by the reassembly */
+		log_frame(src->reasm.buf, src->reasm.len, src->reasm.crc);
+		source_apply(src, src->reasm.buf, src->reasm.len);
+	}
+}
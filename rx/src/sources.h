@@ -0,0 +1,29 @@
+#ifndef SOURCES_H_
+#define SOURCES_H_
+
+#include <stdint.h>
+#include "led.h"
+
+/* A transmitter, identified by its advertised name, owning a range of LEDs. */
+struct source;
+
+/* Start tracking the configured sources. They all render into `strip`. */
+int sources_init(struct led_data *strip, uint16_t len);
+
+/* Returns NULL if `name` isn't a configured source. The name has to match
+ * exactly, not just start with it.
+ */
+struct source *source_find(const char *name);
+
+/* Show a frame received from `src` in its LED range, and mark it fresh. Other
+ * ranges are left alone.
+ */
+void source_update(struct source *src, const uint8_t *data, uint16_t len);
+
+/* Collect one advertised chunk of a frame from `src`. The frame is shown once
+ * all of its chunks are in and it checks out, until then the previous one
+ * stays up.
+ */
+void source_add_chunk(struct source *src, const uint8_t *chunk, uint16_t len);
+
+#endif // SOURCES_H_
@@ -0,0 +1,152 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/l2cap.h>
+#include "stream.h"
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(stream, 1);
+
+/* Give the stack some time to release the connection object */
+#define ADV_RESTART_DELAY K_MSEC(100)
+#define RATE_WINDOW_MS 1000
+
+static stream_frame_cb_t frame_cb;
+static uint16_t frame_max_len;
+
+static struct bt_l2cap_le_chan le_chan;
+static struct k_work_delayable adv_work;
+
+static uint32_t frames;
+static int64_t window_start;
+
+/* The name goes in the advertising data rather than the scan response, as the
+ * transmitter scans passively.
+ */
+static const struct bt_data ad[] = {
+	BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+	BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME,
+		sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+};
+
+static int adv_start(void)
+{
+	int err = bt_le_adv_start(BT_LE_ADV_CONN, ad, ARRAY_SIZE(ad), NULL, 0);
+
+	if (err && err != -EALREADY) {
+		LOG_ERR("connectable adv failed (err %d)", err);
+		return err;
+	}
+
+	return 0;
+}
+
+static void adv_restart(struct k_work *work)
+{
+	if (adv_start()) {
+		k_work_schedule(&adv_work, ADV_RESTART_DELAY);
+	}
+}
+
+static int chan_recv(struct bt_l2cap_chan *chan, struct net_buf *buf)
+{
+	LOG_DBG("len %u", buf->len);
+
+	frame_cb(buf->data, MIN(buf->len, frame_max_len));
+
+	/* Cheap throughput indicator, shows up in the RTT log. */
+	frames++;
+	if (k_uptime_get() - window_start >= RATE_WINDOW_MS) {
+		printk("stream: %u frames/s\n", frames);
+		frames = 0;
+		window_start = k_uptime_get();
+	}
+
+	return 0;
+}
+
+static void chan_connected(struct bt_l2cap_chan *chan)
+{
+	printk("stream: channel up\n");
+	frames = 0;
+	window_start = k_uptime_get();
+}
+
+static void chan_disconnected(struct bt_l2cap_chan *chan)
+{
+	printk("stream: channel down\n");
+}
+
+static const struct bt_l2cap_chan_ops chan_ops = {
+	.recv = chan_recv,
+	.connected = chan_connected,
+	.disconnected = chan_disconnected,
+};
+
+static int chan_accept(struct bt_conn *conn, struct bt_l2cap_chan **chan)
+{
+	if (le_chan.chan.conn) {
+		return -ENOMEM;
+	}
+
+	memset(&le_chan, 0, sizeof(le_chan));
+	le_chan.chan.ops = &chan_ops;
+	le_chan.rx.mtu = frame_max_len;
+	*chan = &le_chan.chan;
+
+	return 0;
+}
+
+static struct bt_l2cap_server server = {
+	.psm = CONFIG_JULETRE_STREAM_PSM,
+	.sec_level = BT_SECURITY_L1,
+	.accept = chan_accept,
+};
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+	if (err) {
+		printk("stream: connection failed (err %u)\n", err);
+		k_work_schedule(&adv_work, ADV_RESTART_DELAY);
+		return;
+	}
+
+	printk("stream: connected\n");
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	printk("stream: disconnected (reason %u)\n", reason);
+
+	/* The transmitter goes back to broadcasting, which the scanner still
+	 * picks up. Make ourselves available for the next connection.
+	 */
+	k_work_schedule(&adv_work, ADV_RESTART_DELAY);
+}
+
+BT_CONN_CB_DEFINE(stream_conn_callbacks) = {
+	.connected = connected,
+	.disconnected = disconnected,
+};
+
+int stream_init(stream_frame_cb_t cb, uint16_t max_len)
+{
+	int err;
+
+	if (!cb) {
+		return -EINVAL;
+	}
+
+	frame_cb = cb;
+	frame_max_len = max_len;
+	k_work_init_delayable(&adv_work, adv_restart);
+
+	err = bt_l2cap_server_register(&server);
+	if (err) {
+		LOG_ERR("L2CAP server register failed (err %d)", err);
+		return err;
+	}
+
+	return adv_start();
+}
@@ -0,0 +1,12 @@
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdint.h>
+
+/* Called from the BT RX thread with a complete frame. */
+typedef void (*stream_frame_cb_t)(const uint8_t *data, uint16_t len);
+
+/* Start accepting streaming connections. Frames are at most `max_len` bytes. */
+int stream_init(stream_frame_cb_t cb, uint16_t max_len);
+
+#endif // STREAM_H_
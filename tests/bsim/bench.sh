@@ -0,0 +1,55 @@
+#!/usr/bin/env bash
+# Throughput/latency benchmark of the tx -> rx link in BabbleSim.
+#
+# Builds both apps for nrf52_bsim with bench.conf (the transmitter generates
+# frames at a fixed rate instead of reading the UART, the receiver checks them
+# instead of driving the strip), runs them on a simulated 2.4GHz channel and
+# summarises the "bench:" lines logged by the receiver every second.
+#
+# Usage: tests/bsim/bench.sh [adv|stream]
+#   SIM_LENGTH  simulated time, in us (default: 30 s)
+#   FPS         frames/s generated by the transmitter (default: 30)
+#   BUILD       build directory (default: build-bsim)
+#
+# Needs a Zephyr workspace (west, ZEPHYR_BASE) and BabbleSim built, with
+# BSIM_OUT_PATH and BSIM_COMPONENTS_PATH set.
+
+set -eu
+
+MODE=${1:-adv}
+SIM_LENGTH=${SIM_LENGTH:-30000000}
+FPS=${FPS:-30}
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+BUILD=${BUILD:-$ROOT/build-bsim}
+SIM_ID=juletre_bench_$MODE
+
+case $MODE in
+	adv) OVERLAY="bench.conf" ;;
+	stream) OVERLAY="stream.conf;bench.conf" ;;
+	*) echo "usage: $0 [adv|stream]" >&2; exit 1 ;;
+esac
+
+: "${BSIM_OUT_PATH:?BabbleSim not found, set BSIM_OUT_PATH}"
+
+west build -p auto -b nrf52_bsim -d "$BUILD/tx-$MODE" "$ROOT/tx" -- \
+	-DOVERLAY_CONFIG="$OVERLAY" -DCONFIG_JULETRE_BENCH_FPS="$FPS"
+west build -p auto -b nrf52_bsim -d "$BUILD/rx-$MODE" "$ROOT/rx" -- \
+	-DOVERLAY_CONFIG="$OVERLAY"
+
+cd "$BSIM_OUT_PATH/bin"
+
+"$BUILD/tx-$MODE/zephyr/zephyr.exe" -s="$SIM_ID" -d=0 > "$BUILD/tx-$MODE.log" &
+"$BUILD/rx-$MODE/zephyr/zephyr.exe" -s="$SIM_ID" -d=1 > "$BUILD/rx-$MODE.log" &
+./bs_2G4_phy_v1 -s="$SIM_ID" -D=2 -sim_length="$SIM_LENGTH" > /dev/null
+wait
+
+# printk goes through bs_trace, which prefixes every line with the device and
+# the simulated time ("d_01: @00:00:01.000000  "). Skip the first window, it
+# includes the connection setup.
+grep -a 'bench:' "$BUILD/rx-$MODE.log" | sed 's/.*bench:/bench:/' | tail -n +2 | awk -v mode="$MODE" -v fps="$FPS" '
+	{ n++; frames += $2; lost += $5; avg += $8; if ($11 > max) max = $11 }
+	END {
+		if (!n) { print mode ": no frames received"; exit 1 }
+		printf "%s @ %d fps: %.1f frames/s, %d lost, latency avg %d us, max %d us\n",
+		       mode, fps, frames / n, lost, avg / n, max
+	}'
@@ -0,0 +1,52 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#include <zephyr/logging/log.h>
+#include "serial.h"
+
+LOG_MODULE_REGISTER(bench, 1);
+
+/* Stands in for the UART driver in serial.c: fills the packet buffer with a
+ * generated frame at a fixed rate, and wakes up the main loop.
+ */
+K_SEM_DEFINE(serial_data, 0, 1);
+
+#define BENCH_PERIOD K_USEC(USEC_PER_SEC / CONFIG_JULETRE_BENCH_FPS)
+
+static struct rx_uart *bench_config;
+static uint32_t seq;
+
+static void bench_frame(struct k_timer *timer)
+{
+    uint8_t *packet = bench_config->packet;
+    uint32_t now_us = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+
+    /* Sequence number and timestamp, checked by the receiver. The rest is a
+     * pattern that changes every frame.
+     */
+    sys_put_le32(++seq, &packet[0]);
+    sys_put_le32(now_us, &packet[4]);
+    memset(&packet[8], (uint8_t)seq, bench_config->packet_max_len - 8);
+
+    bench_config->stats.frames++;
+    k_sem_give(&serial_data);
+}
+
+K_TIMER_DEFINE(bench_timer, bench_frame, NULL);
+
+int serial_init(struct rx_uart* uart_config)
+{
+    bench_config = uart_config;
+    k_timer_start(&bench_timer, BENCH_PERIOD, BENCH_PERIOD);
+
+    printk("bench: sending %u frames/s\n", CONFIG_JULETRE_BENCH_FPS);
+
+    return 0;
+}
+
+void serial_write(struct rx_uart* uart_config, const char *data, size_t len)
+{
+    /* Nowhere to write to */
+}
@@ -0,0 +1,17 @@
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdint.h>
+
+/* Prepended to each chunk of a frame in the advertising data, so the receiver
+ * can put the frame back together and check it. Little-endian, must match
+ * rx/src/frame.h.
+ */
+struct frame_hdr {
+	uint8_t seq;		/* Incremented for every frame */
+	uint16_t offset;	/* Of this chunk in the frame */
+	uint16_t len;		/* Of the whole frame */
+	uint16_t crc;		/* CRC-16/CCITT (0xffff seed) of the whole frame */
+} __packed;
+
+#endif // FRAME_H_
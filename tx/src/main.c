@@ -1,7 +1,11 @@
 #include <zephyr/device.h>
 #include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
 #include <zephyr/sys/ring_buffer.h>
+#include "frame.h"
 #include "serial.h"
+#include "stream.h"
 
 #define NUM_LEDS 68
 #define DATA_LEN (NUM_LEDS * 4)
@@ -23,17 +27,52 @@ static uint8_t ad_data[DATA_LEN];
 				    BT_DEVICE_NAME_LEN)
 #define MAN_DATA_LEN (255 - BT_DEVICE_NAME_AD_DATA_LEN)
 
+/* The frame is split over two manufacturer data elements, each starting with
+ * a header.
+ */
+#define CHUNK0_LEN (MAN_DATA_LEN - sizeof(struct frame_hdr))
+#define CHUNK1_LEN (DATA_LEN - CHUNK0_LEN)
+
+static uint8_t chunk0[sizeof(struct frame_hdr) + CHUNK0_LEN];
+static uint8_t chunk1[sizeof(struct frame_hdr) + CHUNK1_LEN];
+
 static const struct bt_data ad[] = {
-	BT_DATA(BT_DATA_MANUFACTURER_DATA, ad_data, MAN_DATA_LEN),
-	BT_DATA(BT_DATA_MANUFACTURER_DATA, ad_data + MAN_DATA_LEN, DATA_LEN - MAN_DATA_LEN),
+	BT_DATA(BT_DATA_MANUFACTURER_DATA, chunk0, sizeof(chunk0)),
+	BT_DATA(BT_DATA_MANUFACTURER_DATA, chunk1, sizeof(chunk1)),
 };
 
+static void set_chunk(uint8_t *chunk, const struct frame_hdr *frame,
+		      uint16_t offset, uint16_t len)
+{
+	struct frame_hdr hdr = *frame;
+
+	hdr.offset = sys_cpu_to_le16(offset);
+	memcpy(chunk, &hdr, sizeof(hdr));
+	memcpy(chunk + sizeof(hdr), ad_data + offset, len);
+}
+
+/* Split `ad_data` into the advertising data chunks */
+static void update_chunks(void)
+{
+	static uint8_t seq;
+	struct frame_hdr hdr = {
+		.seq = ++seq,
+		.len = sys_cpu_to_le16(DATA_LEN),
+		.crc = sys_cpu_to_le16(crc16_itu_t(0xffff, ad_data, DATA_LEN)),
+	};
+
+	set_chunk(chunk0, &hdr, 0, CHUNK0_LEN);
+	set_chunk(chunk1, &hdr, CHUNK0_LEN, CHUNK1_LEN);
+}
+
 RING_BUF_DECLARE(uart_ringbuf, 512);
 static uint8_t led_data[DATA_LEN];
 
 static struct rx_uart_header uart_header;
 static struct rx_uart config = {
-    .uart = DEVICE_DT_GET(DT_NODELABEL(uart0)),
+    /* Frames are generated internally when benchmarking */
+    .uart = COND_CODE_1(CONFIG_JULETRE_BENCH, (NULL),
+                        (DEVICE_DT_GET(DT_NODELABEL(uart0)))),
     .header = &uart_header,
 	.ringbuf = &uart_ringbuf,
     .packet = led_data,
@@ -50,6 +89,32 @@ extern struct k_sem serial_data;
 
 struct bt_le_ext_adv *adv;
 
+/* Frames that made it on air, see report_stats() */
+static uint32_t adv_updates;
+static uint32_t stream_sent;
+static uint32_t stream_dropped;
+
+/* Report the pipeline counters back to the host after every frame. Frames that
+ * were received but never sent out were superseded by a newer one before the
+ * advertising data (or the stream) could be updated.
+ */
+static void report_stats(void)
+{
+	char line[96];
+	int len;
+
+	if (!IS_ENABLED(CONFIG_JULETRE_REPLAY_STATS)) {
+		return;
+	}
+
+	len = snprintk(line, sizeof(line),
+			   "STAT frames=%u overflow=%u adv=%u stream=%u congested=%u\n",
+			   config.stats.frames, config.stats.overflow,
+			   adv_updates, stream_sent, stream_dropped);
+
+	serial_write(&config, line, MIN(len, sizeof(line) - 1));
+}
+
 void main(void)
 {
 	struct bt_le_adv_param adv_param = {
@@ -72,23 +137,55 @@ void main(void)
 	/* Create a non-connectable non-scannable advertising set */
 	VALIDATE(bt_le_ext_adv_create(&adv_param, NULL, &adv));
 
+	if (IS_ENABLED(CONFIG_JULETRE_STREAM)) {
+		VALIDATE(stream_init());
+	}
+
 	while (true) {
 		/* Wait until we have received fresh data over serial */
 		k_sem_take(&serial_data, K_FOREVER);
+
+		/* Update the data */
+		memcpy(ad_data, led_data, sizeof(ad_data));
+
+		if (IS_ENABLED(CONFIG_JULETRE_STREAM) && stream_is_ready()) {
+			/* The receiver gets the frames over the connection, free
+			 * up the radio for it.
+			 */
+			VALIDATE(bt_le_ext_adv_stop(adv));
+
+			/* Frames dropped due to congestion are superseded by the
+			 * next one, only fall back to advertising if the link is
+			 * gone.
+			 */
+			int err = stream_send(ad_data, sizeof(ad_data));
+
+			if (err != -ENOTCONN) {
+				if (err) {
+					stream_dropped++;
+				} else {
+					stream_sent++;
+				}
+				report_stats();
+				continue;
+			}
+		}
+
 		printk("Refreshing Advertising Data...");
 
 		/* Stop adv (to be able to update long data) */
 		VALIDATE(bt_le_ext_adv_stop(adv));
 
-		/* Update the data */
-		memcpy(ad_data, led_data, sizeof(ad_data));
+		update_chunks();
 
 		/* Set extended advertising data */
 		VALIDATE(bt_le_ext_adv_set_data(adv, ad, ARRAY_SIZE(ad), NULL, 0));
 
 		/* Start extended advertising set */
 		VALIDATE(bt_le_ext_adv_start(adv, BT_LE_EXT_ADV_START_DEFAULT));
+		adv_updates++;
 
 		printk("done.\n");
+		report_stats();
 	}
 }
@@ -101,6 +101,7 @@ static void process_ringbuf(struct rx_uart *uart_config)
                 LOG_DBG("store ringbuf");
                 memset(uart_config->packet, 0, uart_config->packet_max_len);
                 ring_buf_get(uart_config->ringbuf, uart_config->packet, len);
+                uart_config->stats.frames++;
                 k_sem_give(&serial_data);
                 LOG_HEXDUMP_DBG(uart_config->packet, uart_config->packet_max_len, "buffer");
                 cleanup_state(uart_config);
@@ -133,7 +134,9 @@ void serial_cb(const struct device *uart, void *user_data)
         uint8_t byte = 0; /* Have to assign to stop GCC from whining */
         while(uart_fifo_read(uart, &byte, 1) > 0) {
             uint32_t ret = ring_buf_put(uart_config->ringbuf, &byte, 1);
-            (void)ret; /* Don't warn if logging is disabled */
+            if (ret == 0) {
+                uart_config->stats.overflow++;
+            }
 
             LOG_DBG("rx: %x, rb put %u", byte, ret);
 
@@ -159,3 +162,10 @@ int serial_init(struct rx_uart* uart_config)
 
     return 0;
 }
+
+void serial_write(struct rx_uart* uart_config, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        uart_poll_out(uart_config->uart, data[i]);
+    }
+}
@@ -8,6 +8,11 @@ struct rx_uart_header {
     uint8_t idx;		/* Current index, used when building header */
 };
 
+struct rx_uart_stats {
+    uint32_t frames;		/* Complete frames stored in `packet` */
+    uint32_t overflow;		/* Bytes dropped because the ring buffer was full */
+};
+
 struct rx_uart {
     const struct device *uart;
 
@@ -19,8 +24,13 @@ struct rx_uart {
     /* packet buffer: stores only the packet to be sent out */
     char *packet;
     uint16_t packet_max_len;
+
+    struct rx_uart_stats stats;
 };
 
 int serial_init(struct rx_uart* uart_config);
 
+/* Blocking write, used to report stats back to the host. */
+void serial_write(struct rx_uart* uart_config, const char *data, size_t len);
+
 #endif // SERIAL_H_
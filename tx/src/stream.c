@@ -0,0 +1,214 @@
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/l2cap.h>
+#include <zephyr/sys/atomic.h>
+#include "stream.h"
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(stream, 1);
+
+#define PEER_NAME CONFIG_JULETRE_STREAM_PEER_NAME
+#define NAME_LEN 30
+
+/* 7.5ms connection interval, 4s supervision timeout */
+#define STREAM_CONN_PARAM BT_LE_CONN_PARAM(6, 6, 0, 400)
+
+/* Double-buffered: one frame in flight, one being queued */
+NET_BUF_POOL_FIXED_DEFINE(stream_pool, 2,
+			  BT_L2CAP_SDU_BUF_SIZE(CONFIG_BT_L2CAP_TX_MTU),
+			  CONFIG_BT_CONN_TX_USER_DATA_SIZE, NULL);
+
+/* Wakes up the main loop, so it goes back to advertising */
+extern struct k_sem serial_data;
+
+static struct bt_conn *conn;
+static struct bt_l2cap_le_chan le_chan;
+static atomic_t chan_ready;
+
+static void scan_start(void);
+
+static int chan_recv(struct bt_l2cap_chan *chan, struct net_buf *buf)
+{
+	/* Nothing is expected from the receiver */
+	return 0;
+}
+
+static void chan_connected(struct bt_l2cap_chan *chan)
+{
+	printk("stream: channel up, tx mtu %u\n", le_chan.tx.mtu);
+	atomic_set(&chan_ready, 1);
+}
+
+static void chan_disconnected(struct bt_l2cap_chan *chan)
+{
+	printk("stream: channel down\n");
+	atomic_clear(&chan_ready);
+
+	/* Also called when the receiver rejects the channel. The receiver
+	 * doesn't take a second connection, so drop this one: disconnected()
+	 * then rescans and the receiver advertises again.
+	 */
+	if (conn) {
+		bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+	}
+
+	/* Re-broadcast the last frame right away */
+	k_sem_give(&serial_data);
+}
+
+static const struct bt_l2cap_chan_ops chan_ops = {
+	.recv = chan_recv,
+	.connected = chan_connected,
+	.disconnected = chan_disconnected,
+};
+
+static bool name_cb(struct bt_data *data, void *user_data)
+{
+	bool *found = user_data;
+
+	switch (data->type) {
+	case BT_DATA_NAME_SHORTENED:
+	case BT_DATA_NAME_COMPLETE:
+		*found = (data->data_len == strlen(PEER_NAME)) &&
+			!memcmp(data->data, PEER_NAME, data->data_len);
+		return false;
+	default:
+		return true;
+	}
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+			 struct net_buf_simple *ad)
+{
+	bool found = false;
+	int err;
+
+	if (conn || type != BT_GAP_ADV_TYPE_ADV_IND) {
+		return;
+	}
+
+	bt_data_parse(ad, name_cb, &found);
+	if (!found) {
+		return;
+	}
+
+	if (bt_le_scan_stop()) {
+		return;
+	}
+
+	err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN,
+				STREAM_CONN_PARAM, &conn);
+	if (err) {
+		LOG_ERR("create conn failed (err %d)", err);
+		scan_start();
+	}
+}
+
+static void scan_start(void)
+{
+	int err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, device_found);
+
+	if (err && err != -EALREADY) {
+		LOG_ERR("scan start failed (err %d)", err);
+	}
+}
+
+static void connected(struct bt_conn *c, uint8_t err)
+{
+	if (c != conn) {
+		return;
+	}
+
+	if (err) {
+		printk("stream: connection failed (err %u)\n", err);
+		bt_conn_unref(conn);
+		conn = NULL;
+		scan_start();
+		return;
+	}
+
+	printk("stream: connected\n");
+
+	/* Best effort: the channel still works on 1M and 27-byte PDUs */
+	err = bt_conn_le_phy_update(conn, BT_CONN_LE_PHY_PARAM_2M);
+	if (err) {
+		LOG_ERR("phy update failed (err %d)", err);
+	}
+
+	err = bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX);
+	if (err) {
+		LOG_ERR("data len update failed (err %d)", err);
+	}
+
+	le_chan.chan.ops = &chan_ops;
+	err = bt_l2cap_chan_connect(conn, &le_chan.chan, CONFIG_JULETRE_STREAM_PSM);
+	if (err) {
+		LOG_ERR("chan connect failed (err %d)", err);
+		bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+	}
+}
+
+static void disconnected(struct bt_conn *c, uint8_t reason)
+{
+	if (c != conn) {
+		return;
+	}
+
+	printk("stream: disconnected (reason %u)\n", reason);
+
+	atomic_clear(&chan_ready);
+	bt_conn_unref(conn);
+	conn = NULL;
+
+	/* Re-broadcast the last frame right away, then look for the receiver
+	 * again.
+	 */
+	k_sem_give(&serial_data);
+	scan_start();
+}
+
+BT_CONN_CB_DEFINE(stream_conn_callbacks) = {
+	.connected = connected,
+	.disconnected = disconnected,
+};
+
+bool stream_is_ready(void)
+{
+	return atomic_get(&chan_ready);
+}
+
+int stream_send(const uint8_t *data, uint16_t len)
+{
+	struct net_buf *buf;
+	int err;
+
+	if (!stream_is_ready()) {
+		return -ENOTCONN;
+	}
+
+	/* Don't queue stale frames behind a congested link */
+	buf = net_buf_alloc(&stream_pool, K_NO_WAIT);
+	if (!buf) {
+		return -ENOBUFS;
+	}
+
+	net_buf_reserve(buf, BT_L2CAP_SDU_CHAN_SEND_RESERVE);
+	net_buf_add_mem(buf, data, MIN(len, le_chan.tx.mtu));
+
+	err = bt_l2cap_chan_send(&le_chan.chan, buf);
+	if (err < 0) {
+		net_buf_unref(buf);
+		return err;
+	}
+
+	return 0;
+}
+
+int stream_init(void)
+{
+	scan_start();
+
+	return 0;
+}
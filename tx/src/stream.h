@@ -0,0 +1,18 @@
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Start looking for a receiver to connect to. */
+int stream_init(void);
+
+/* True when a receiver is connected and the channel is up. */
+bool stream_is_ready(void);
+
+/* Returns -ENOTCONN if no receiver is connected, -ENOBUFS if the link is
+ * congested and the frame was dropped.
+ */
+int stream_send(const uint8_t *data, uint16_t len);
+
+#endif // STREAM_H_